@@ -83,12 +83,12 @@ std::unique_ptr<ecs_history::component_change_t<Type> > deserialize_change(Archi
         if (!old_value) {
             throw std::runtime_error("construction of component failed");
         }
-        serialize_component<Archive, false>(archive, old_value);
+        serialize_component<Archive, false>(archive, old_value.as_ref());
         entt::meta_any new_value = type.construct();
         if (!new_value) {
             throw std::runtime_error("construction of component failed");
         }
-        serialize_component<Archive, false>(archive, new_value);
+        serialize_component<Archive, false>(archive, new_value.as_ref());
         return std::make_unique<ecs_history::update_change_t<Type> >(
             static_entity,
             old_value.cast<Type>(),
@@ -99,7 +99,7 @@ std::unique_ptr<ecs_history::component_change_t<Type> > deserialize_change(Archi
         if (!new_value) {
             throw std::runtime_error("construction of component failed");
         }
-        serialize_component<Archive, false>(archive, new_value);
+        serialize_component<Archive, false>(archive, new_value.as_ref());
         return std::make_unique<ecs_history::update_change_t<Type> >(
             static_entity,
             Type{},
@@ -110,7 +110,7 @@ std::unique_ptr<ecs_history::component_change_t<Type> > deserialize_change(Archi
         if (!old_value) {
             throw std::runtime_error("construction of component failed");
         }
-        serialize_component<Archive, false>(archive, old_value);
+        serialize_component<Archive, false>(archive, old_value.as_ref());
         return std::make_unique<ecs_history::destruct_change_t<Type> >(
             static_entity,
             old_value.cast<Type>());
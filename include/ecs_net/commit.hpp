@@ -74,7 +74,7 @@ struct commit_t {
 
     commit_t(commit_t &&commit) = default;
 
-    commit_t invert() {
+    [[nodiscard]] commit_t invert() const {
         commit_t inverted_commit{};
         inverted_commit.created_entities = this->destroyed_entities;
         inverted_commit.destroyed_entities = this->created_entities;
@@ -5,6 +5,8 @@
 #ifndef ECS_NET_COMPONENT_SERIALIZER_HPP
 #define ECS_NET_COMPONENT_SERIALIZER_HPP
 
+#include <type_traits>
+
 #include <entt/entt.hpp>
 #include "cereal/types/string.hpp"
 
@@ -13,11 +15,25 @@ using namespace entt::literals;
 namespace ecs_net::serialization {
     enum class traits_t : uint16_t {
         NO = 0x00,
+        // The component is trivially copyable, snapshots copy it as raw bytes. Set it with trivial_component.
         TRIVIAL = 0x01,
 
         _entt_enum_as_bitmask
     };
 
+    /**
+     * Registers a component with traits_t::TRIVIAL, checking that it is trivially copyable
+     * @tparam Type The component
+     * @return The meta factory of the component for further registration
+     */
+    template<typename Type>
+    entt::meta_factory<Type> trivial_component() {
+        static_assert(std::is_trivially_copyable_v<Type>, "TRIVIAL components must be trivially copyable");
+        entt::meta_factory<Type> factory{};
+        factory.traits(traits_t::TRIVIAL);
+        return factory;
+    }
+
     /**
      *
      * @tparam Archive The type of Archive to write to / read from
@@ -6,7 +6,11 @@
 #define ECS_NET_ENTITY_VERSION_HPP
 
 #include <cstdint>
+#include <deque>
 #include <unordered_map>
+#include <vector>
+
+#include <entt/entt.hpp>
 
 #include "ecs_history/static_entity.hpp"
 
@@ -16,16 +20,51 @@
 
 namespace ecs_net {
     using entity_version_t = ENTITY_VERSION_TYPE;
+    // Local, monotonically increasing counter of applied commits. Never sent inside commits.
+    using generation_t = uint64_t;
 
     class entity_version_handler_t {
+        struct entity_generation_t {
+            generation_t generation;
+            bool destroyed;
+        };
+
         std::unordered_map<ecs_history::static_entity_t, entity_version_t> versions;
+        // Identifies this handler, generations of different handlers are not comparable
+        uint64_t epoch;
+        generation_t generation = 0;
+        // Generations up to the horizon are pruned and cannot be used to compute changes anymore
+        generation_t horizon = 0;
+        // Number of non-empty commits a reconnecting client may be behind
+        generation_t retained_generations = 1024;
+        // Generation of the last commit touching an entity / storage
+        std::unordered_map<ecs_history::static_entity_t, entity_generation_t> entity_generations;
+        // Entities in the order they were marked, to find changes and prune without a full scan
+        std::deque<std::pair<generation_t, ecs_history::static_entity_t> > entity_log;
+        std::unordered_map<entt::id_type, generation_t> storage_generations;
+
+        void prune();
 
     public:
+        entity_version_handler_t();
+
         [[nodiscard]] entity_version_t get_version(ecs_history::static_entity_t entity);
         void set_version(ecs_history::static_entity_t entity, entity_version_t version);
         entity_version_t increment_version(ecs_history::static_entity_t entity);
         void remove_entity(ecs_history::static_entity_t entity);
         void add_entity(ecs_history::static_entity_t entity, entity_version_t version);
+
+        [[nodiscard]] uint64_t get_epoch() const;
+        [[nodiscard]] generation_t get_generation() const;
+        [[nodiscard]] generation_t get_horizon() const;
+        void set_retained_generations(generation_t generations);
+        generation_t next_generation();
+        void mark_entity(ecs_history::static_entity_t entity, bool destroyed = false);
+        void mark_storage(entt::id_type storage);
+        [[nodiscard]] bool is_destroyed(ecs_history::static_entity_t entity) const;
+        [[nodiscard]] generation_t get_storage_generation(entt::id_type storage) const;
+        [[nodiscard]] bool can_serialize_since(uint64_t epoch, generation_t since) const;
+        [[nodiscard]] std::vector<ecs_history::static_entity_t> changed_entities(generation_t since) const;
     };
 }
 
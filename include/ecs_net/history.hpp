@@ -0,0 +1,252 @@
+//
+// Created by felix on 1/12/26.
+//
+
+#ifndef ECS_NET_HISTORY_HPP
+#define ECS_NET_HISTORY_HPP
+
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+
+#include "cereal/archives/portable_binary.hpp"
+#include "ecs_net/registry.hpp"
+#include "ecs_net/serialization.hpp"
+
+namespace ecs_net {
+struct history_options_t {
+    // Maximum number of commits kept in the history. Older commits are dropped.
+    size_t max_entries = 1024;
+    // Maximum number of changes kept in memory. Commits farthest away from the current
+    // position are spilled to disk when exceeded. Only used if a spill directory is set.
+    size_t max_resident_changes = 1 << 16;
+    std::optional<std::filesystem::path> spill_directory;
+};
+
+/**
+ * A commit applied by history_t::undo / history_t::redo. The commit stays valid until
+ * the history is used again. Undo and redo are applied with monitors disabled, so they
+ * are not part of the next registry_t::commit_changes. To send them to peers, serialize
+ * the commit for FORWARD or its invert() for REVERSE yourself.
+ */
+struct history_step_t {
+    const commit_t *commit;
+    apply_direction_t direction;
+};
+
+/**
+ * Local undo / redo journal for locally recorded commits.
+ * Every commit is stored exactly once and undone by applying it in reverse direction,
+ * so undo and redo never copy or invert commits.
+ */
+class history_t {
+    struct entry_t {
+        std::unique_ptr<commit_t> commit;
+        std::filesystem::path spill_path;
+        size_t weight;
+    };
+
+    registry_t &registry;
+    history_options_t options;
+    std::deque<entry_t> entries;
+    // entries before the cursor are applied, entries from the cursor on can be redone
+    size_t cursor = 0;
+    size_t resident_weight = 0;
+    // Unique per instance, so histories can share a spill directory
+    std::filesystem::path spill_directory;
+    uint64_t next_spill_id = 0;
+
+public:
+    explicit history_t(registry_t &registry, history_options_t options = {})
+        : registry(registry), options(std::move(options)) {
+        if (this->options.spill_directory) {
+            const commit_id id = commit_id_generator_t{}.next();
+            this->spill_directory = *this->options.spill_directory /
+                                    ("history_" + std::to_string(id.part1) + "_" + std::to_string(id.part2));
+            std::filesystem::create_directories(this->spill_directory);
+        }
+    }
+
+    history_t(history_t &history) = delete;
+
+    history_t &operator=(history_t &history) = delete;
+
+    ~history_t() {
+        if (!this->spill_directory.empty()) {
+            std::error_code error;
+            std::filesystem::remove_all(this->spill_directory, error);
+        }
+    }
+
+    /**
+     * Records a commit that was already applied to the registry, e.g. the result of
+     * registry_t::commit_changes. Discards all commits that could have been redone.
+     * @param commit The commit
+     */
+    void record(std::unique_ptr<commit_t> commit) {
+        while (this->entries.size() > this->cursor) {
+            drop(this->entries.back());
+            this->entries.pop_back();
+        }
+        const size_t weight = commit_weight(*commit);
+        this->entries.push_back(entry_t{std::move(commit), {}, weight});
+        this->resident_weight += weight;
+        ++this->cursor;
+
+        while (this->entries.size() > this->options.max_entries) {
+            drop(this->entries.front());
+            this->entries.pop_front();
+            --this->cursor;
+        }
+        enforce_resident_limit();
+    }
+
+    [[nodiscard]] bool can_undo() const {
+        return this->cursor > 0;
+    }
+
+    [[nodiscard]] bool can_redo() const {
+        return this->cursor < this->entries.size();
+    }
+
+    /**
+     * Undoes the last applied commit.
+     * Throws if the entity versions changed since the commit was applied, e.g. by a remote commit.
+     * @return The undone commit, std::nullopt if there is nothing to undo
+     */
+    std::optional<history_step_t> undo() {
+        if (!can_undo()) {
+            return std::nullopt;
+        }
+        return step(this->cursor - 1, apply_direction_t::REVERSE);
+    }
+
+    /**
+     * Reapplies the last undone commit.
+     * Throws if the entity versions changed since the commit was undone, e.g. by a remote commit.
+     * @return The reapplied commit, std::nullopt if there is nothing to redo
+     */
+    std::optional<history_step_t> redo() {
+        if (!can_redo()) {
+            return std::nullopt;
+        }
+        return step(this->cursor, apply_direction_t::FORWARD);
+    }
+
+    [[nodiscard]] size_t size() const {
+        return this->entries.size();
+    }
+
+    [[nodiscard]] size_t resident_changes() const {
+        return this->resident_weight;
+    }
+
+private:
+    history_step_t step(const size_t index, const apply_direction_t direction) {
+        const commit_t &commit = load(this->entries[index]);
+        if (!this->registry.can_apply(commit, direction)) {
+            throw std::runtime_error("entity versions changed since the history entry was recorded");
+        }
+        this->registry.apply_commit(commit, direction);
+        this->cursor = direction == apply_direction_t::REVERSE ? index : index + 1;
+        enforce_resident_limit();
+        return history_step_t{&commit, direction};
+    }
+
+    static size_t commit_weight(const commit_t &commit) {
+        size_t weight = commit.created_entities.size() + commit.destroyed_entities.size();
+        for (const auto &change_set : commit.change_sets) {
+            weight += change_set->count();
+        }
+        return weight;
+    }
+
+    const commit_t &load(entry_t &entry) {
+        if (!entry.commit) {
+            std::ifstream stream{entry.spill_path, std::ios::binary};
+            if (!stream) {
+                throw std::runtime_error("could not open spilled history entry " + entry.spill_path.string());
+            }
+            cereal::PortableBinaryInputArchive archive{stream};
+            entry.commit = serialization::deserialize_commit(archive);
+            this->resident_weight += entry.weight;
+        }
+        return *entry.commit;
+    }
+
+    /**
+     * Moves an entry out of memory. The entry stays resident if its spill file could not be written.
+     * @return Whether the entry was spilled
+     */
+    bool spill(entry_t &entry) {
+        if (entry.spill_path.empty()) {
+            const std::filesystem::path spill_path =
+                this->spill_directory / (std::to_string(this->next_spill_id++) + ".commit");
+            std::ofstream stream{spill_path, std::ios::binary | std::ios::trunc};
+            if (stream) {
+                cereal::PortableBinaryOutputArchive archive{stream};
+                // Old values are needed to undo the commit later on
+                serialization::serialize_commit<cereal::PortableBinaryOutputArchive, false>(archive, *entry.commit);
+            }
+            stream.flush();
+            const bool written = stream.good();
+            stream.close();
+            if (!written || stream.fail()) {
+                std::error_code error;
+                std::filesystem::remove(spill_path, error);
+                return false;
+            }
+            entry.spill_path = spill_path;
+        }
+        // A commit is never modified, so an existing spill file is still valid
+        entry.commit.reset();
+        this->resident_weight -= entry.weight;
+        return true;
+    }
+
+    void drop(entry_t &entry) {
+        if (entry.commit) {
+            this->resident_weight -= entry.weight;
+        }
+        remove_spill_file(entry);
+    }
+
+    static void remove_spill_file(const entry_t &entry) {
+        if (!entry.spill_path.empty()) {
+            std::error_code error;
+            std::filesystem::remove(entry.spill_path, error);
+        }
+    }
+
+    void enforce_resident_limit() {
+        if (!this->options.spill_directory) {
+            return;
+        }
+        // The entries next to the cursor are the next ones to be undone / redone
+        size_t front = 0;
+        size_t back = this->entries.size();
+        while (this->resident_weight > this->options.max_resident_changes) {
+            while (front < this->cursor && !this->entries[front].commit) {
+                ++front;
+            }
+            while (back > this->cursor && !this->entries[back - 1].commit) {
+                --back;
+            }
+            const size_t front_distance = front + 1 < this->cursor ? this->cursor - front : 0;
+            const size_t back_distance = back > this->cursor + 1 ? back - this->cursor : 0;
+            if (front_distance == 0 && back_distance == 0) {
+                return;
+            }
+            entry_t &entry = front_distance >= back_distance ? this->entries[front++] : this->entries[--back];
+            if (!spill(entry)) {
+                // Keep everything resident until writing spill files works again
+                return;
+            }
+        }
+    }
+};
+}
+
+#endif //ECS_NET_HISTORY_HPP
@@ -9,6 +9,41 @@
 #include "ecs_history/gather_strategy/registry.hpp"
 
 namespace ecs_net {
+enum class apply_direction_t : uint8_t {
+    FORWARD = 0,
+    REVERSE = 1
+};
+
+/**
+ * Forwards every change to another supplier with its direction flipped, so a
+ * recorded commit can be undone in place without building an inverted copy.
+ */
+class reverse_change_supplier_t final : public ecs_history::any_change_supplier_t {
+public:
+    explicit reverse_change_supplier_t(ecs_history::any_change_supplier_t &supplier)
+        : supplier(supplier) {
+    }
+
+    void apply_construct(ecs_history::static_entity_t static_entity,
+                         entt::meta_any &value) override {
+        supplier.apply_destruct(static_entity, value);
+    }
+
+    void apply_update(ecs_history::static_entity_t static_entity,
+                      entt::meta_any &old_value,
+                      entt::meta_any &new_value) override {
+        supplier.apply_update(static_entity, new_value, old_value);
+    }
+
+    void apply_destruct(ecs_history::static_entity_t static_entity,
+                        entt::meta_any &old_value) override {
+        supplier.apply_construct(static_entity, old_value);
+    }
+
+private:
+    ecs_history::any_change_supplier_t &supplier;
+};
+
 class registry_t : public ecs_history::registry_t {
     entity_version_handler_t &version_handler;
 
@@ -70,19 +105,41 @@ public:
             commit->entity_versions[static_entity] = this->version_handler.increment_version(
                 static_entity);
         }
+        mark_generation(*commit, apply_direction_t::FORWARD);
 
         return std::move(commit);
     }
 
-    bool can_apply(const commit_t &commit) {
+    /**
+     * Checks whether the entity versions of the registry match the commit.
+     * REVERSE expects the versions the commit left behind when it was applied.
+     * @param commit The commit
+     * @param direction Whether the commit is going to be applied or undone
+     */
+    [[nodiscard]] bool can_apply(const commit_t &commit,
+                                 const apply_direction_t direction = apply_direction_t::FORWARD) const {
         return std::ranges::all_of(commit.entity_versions,
                                    [&](const auto &pair) {
-                                       return pair.second == this->version_handler.get_version(
+                                       entity_version_t expected = pair.second;
+                                       if (direction == apply_direction_t::REVERSE) {
+                                           commit.undo ? --expected : ++expected;
+                                       }
+                                       return expected == this->version_handler.get_version(
                                                   pair.first);
                                    });
     }
 
-    void apply_commit(const commit_t &commit) const {
+    /**
+     * Applies a commit to the registry.
+     * REVERSE undoes a commit that was previously applied (or committed locally) without
+     * inverting it first. This requires the commit to contain old values, so commits
+     * received with only new values cannot be reversed.
+     * @param commit The commit
+     * @param direction Whether to apply or to undo the commit
+     */
+    void apply_commit(const commit_t &commit,
+                      const apply_direction_t direction = apply_direction_t::FORWARD) const {
+        const bool reverse = direction == apply_direction_t::REVERSE;
         if (this->handle.ctx().contains<std::vector<std::shared_ptr<
             ecs_history::base_component_monitor_t> > >()) {
             const auto &monitors = this->handle.ctx().get<std::vector<std::shared_ptr<
@@ -100,23 +157,39 @@ public:
             destroyed_storage.reset();
         }
 
-        for (const ecs_history::static_entity_t &created_entity : commit.created_entities) {
+        const auto &created_entities = reverse ? commit.destroyed_entities : commit.created_entities;
+        const auto &destroyed_entities = reverse ? commit.created_entities : commit.destroyed_entities;
+
+        for (const ecs_history::static_entity_t &created_entity : created_entities) {
             const entt::entity entt = this->handle.create();
             this->static_entities.create(entt, created_entity);
         }
         ecs_history::any_change_applier_t applier{this->handle, this->static_entities};
-        for (const auto &change : commit.change_sets) {
-            change->supply(applier);
+        if (reverse) {
+            reverse_change_supplier_t reverse_applier{applier};
+            for (auto change = commit.change_sets.rbegin(); change != commit.change_sets.rend(); ++change) {
+                (*change)->supply(reverse_applier);
+            }
+        } else {
+            for (const auto &change : commit.change_sets) {
+                change->supply(applier);
+            }
         }
-        for (const ecs_history::static_entity_t &removed_entity : commit.destroyed_entities) {
+        for (const ecs_history::static_entity_t &removed_entity : destroyed_entities) {
             const auto entt = this->static_entities.remove(removed_entity);
             this->handle.destroy(entt);
         }
         for (const auto &[entity, version] : commit.entity_versions) {
-            commit.undo
-                ? this->version_handler.set_version(entity, version-1)
-                : this->version_handler.set_version(entity, version+1);
+            if (reverse) {
+                // Same result as applying commit.invert(): the version from before the commit
+                this->version_handler.set_version(entity, version);
+            } else {
+                commit.undo
+                    ? this->version_handler.set_version(entity, version-1)
+                    : this->version_handler.set_version(entity, version+1);
+            }
         }
+        mark_generation(commit, direction);
 
         if (this->handle.ctx().contains<std::vector<std::shared_ptr<
             ecs_history::base_component_monitor_t> > >()) {
@@ -135,6 +208,30 @@ public:
             destroyed_storage.on_destroy<entt::entity>();
         }
     }
+
+private:
+    void mark_generation(const commit_t &commit, const apply_direction_t direction) const {
+        // Empty commits (e.g. one commit_changes per tick) must not move the retained window
+        if (commit.entity_versions.empty() && std::ranges::all_of(commit.change_sets, [](const auto &change_set) {
+            return change_set->count() == 0;
+        })) {
+            return;
+        }
+        this->version_handler.next_generation();
+        const auto &destroyed_entities = direction == apply_direction_t::REVERSE
+                                             ? commit.created_entities
+                                             : commit.destroyed_entities;
+        const std::unordered_set<ecs_history::static_entity_t> destroyed{
+            destroyed_entities.begin(), destroyed_entities.end()};
+        for (const auto &[entity, version] : commit.entity_versions) {
+            this->version_handler.mark_entity(entity, destroyed.contains(entity));
+        }
+        for (const auto &change_set : commit.change_sets) {
+            if (change_set->count() > 0) {
+                this->version_handler.mark_storage(change_set->id);
+            }
+        }
+    }
 };
 }
 
@@ -0,0 +1,241 @@
+//
+// Created by felix on 1/14/26.
+//
+
+#ifndef ECS_NET_SCHEMA_HPP
+#define ECS_NET_SCHEMA_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "serialization.hpp"
+
+namespace ecs_net::serialization {
+template<typename Archive>
+using change_set_decoder_t = std::unique_ptr<ecs_history::base_change_set_t>(*)(Archive &);
+
+/**
+ * Registered as meta func "change_set_decoder"_hs to make a component part of the schema:
+ * entt::meta_factory<T>().func<change_set_decoder<cereal::PortableBinaryInputArchive, T>>("change_set_decoder"_hs)
+ * @return Typed pointer to deserialize_change_set for the component
+ */
+template<typename Archive, typename Type>
+change_set_decoder_t<Archive> change_set_decoder() {
+    return &deserialize_change_set<Archive, Type>;
+}
+
+inline uint64_t hash_combine(const uint64_t seed, const uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+/**
+ * Hashes the serialized layout of a type, following the same rules as serialize_component.
+ * Types with a custom serialize func are hashed by their id only.
+ * @param type The type
+ * @param ancestors Types currently being hashed, a repeated one is hashed as a back-reference
+ * @return The schema hash
+ */
+inline uint64_t hash_component_schema(const entt::meta_type &type,
+                                      std::unordered_set<entt::id_type> &ancestors) {
+    uint64_t hash = type.id();
+    if (type.func("serialize"_hs)) {
+        return hash;
+    }
+    if (!ancestors.insert(type.id()).second) {
+        // Recursive types like struct node { std::vector<node> children; }
+        return hash_combine(hash, "back_reference"_hs);
+    }
+    if (type.is_sequence_container()) {
+        entt::meta_any value = type.construct();
+        hash = hash_combine(hash, hash_component_schema(value.as_sequence_container().value_type(), ancestors));
+    } else if (type.is_associative_container()) {
+        entt::meta_any value = type.construct();
+        auto assoc = value.as_associative_container();
+        hash = hash_combine(hash, hash_component_schema(assoc.key_type(), ancestors));
+        hash = hash_combine(hash, hash_component_schema(assoc.mapped_type(), ancestors));
+    } else {
+        for (const auto &[id, data] : type.data()) {
+            hash = hash_combine(hash, id);
+            hash = hash_combine(hash, hash_component_schema(data.type(), ancestors));
+        }
+    }
+    ancestors.erase(type.id());
+    return hash;
+}
+
+inline uint64_t hash_component_schema(const entt::meta_type &type) {
+    std::unordered_set<entt::id_type> ancestors;
+    return hash_component_schema(type, ancestors);
+}
+
+struct component_schema_t {
+    entt::id_type id;
+    uint64_t hash;
+
+    template<class Archive>
+    void serialize(Archive &ar) {
+        ar(id, hash);
+    }
+};
+
+/**
+ * The components one side of a connection can send, in wire index order.
+ */
+struct schema_t {
+    std::vector<component_schema_t> components;
+
+    /**
+     * Builds the schema of all components with a "change_set_decoder"_hs func, sorted by id
+     * @return The local schema
+     */
+    static schema_t local() {
+        schema_t schema;
+        for (const auto &[id, type] : entt::resolve()) {
+            if (!type.func("change_set_decoder"_hs)) {
+                continue;
+            }
+            schema.components.push_back(component_schema_t{type.id(), hash_component_schema(type)});
+        }
+        std::ranges::sort(schema.components, {}, &component_schema_t::id);
+        return schema;
+    }
+};
+
+template<typename Archive>
+void serialize_schema(Archive &archive, const schema_t &schema) {
+    if (schema.components.size() > UINT16_MAX) {
+        throw std::runtime_error("schema contains more than " + std::to_string(UINT16_MAX) + " components");
+    }
+    uint16_t count = schema.components.size();
+    archive(count);
+    for (component_schema_t component : schema.components) {
+        archive(component);
+    }
+}
+
+template<typename Archive>
+schema_t deserialize_schema(Archive &archive) {
+    uint16_t count;
+    archive(count);
+    schema_t schema;
+    schema.components.resize(count);
+    for (uint16_t i = 0; i < count; ++i) {
+        archive(schema.components[i]);
+    }
+    return schema;
+}
+
+/**
+ * Maps component ids to wire indices of the local schema, which was sent to the peer.
+ */
+class schema_encoder_t {
+    std::unordered_map<entt::id_type, uint16_t> indices;
+
+public:
+    explicit schema_encoder_t(const schema_t &local_schema) {
+        for (uint16_t i = 0; i < local_schema.components.size(); ++i) {
+            this->indices.emplace(local_schema.components[i].id, i);
+        }
+    }
+
+    [[nodiscard]] uint16_t index(const entt::id_type id) const {
+        const auto it = this->indices.find(id);
+        if (it == this->indices.end()) {
+            throw std::runtime_error("component " + std::to_string(id) + " is not part of the schema");
+        }
+        return it->second;
+    }
+};
+
+/**
+ * Dense per-connection table of decode functions, indexed by the peer's wire indices.
+ * Construction fails if the peer sends a component unknown locally or with a different layout.
+ */
+template<typename Archive>
+class schema_decoder_t {
+    std::vector<change_set_decoder_t<Archive> > decoders;
+
+public:
+    explicit schema_decoder_t(const schema_t &remote_schema) {
+        this->decoders.reserve(remote_schema.components.size());
+        for (const component_schema_t &component : remote_schema.components) {
+            const entt::meta_type type = entt::resolve(component.id);
+            if (!type) {
+                throw std::runtime_error("peer schema contains unknown component " + std::to_string(component.id));
+            }
+            const auto type_name = std::string{type.info().name()};
+            const auto decoder_func = type.func("change_set_decoder"_hs);
+            if (!decoder_func) {
+                throw std::runtime_error("could not find change set decoder function for type " + type_name);
+            }
+            if (hash_component_schema(type) != component.hash) {
+                throw std::runtime_error("schema mismatch for type " + type_name);
+            }
+            const entt::meta_any decoder = decoder_func.invoke({});
+            const auto *typed_decoder = decoder.template try_cast<const change_set_decoder_t<Archive> >();
+            if (!typed_decoder) {
+                throw std::runtime_error("change set decoder registered for a different archive for type " + type_name);
+            }
+            this->decoders.push_back(*typed_decoder);
+        }
+    }
+
+    [[nodiscard]] change_set_decoder_t<Archive> decoder(const uint16_t index) const {
+        if (index >= this->decoders.size()) {
+            throw std::runtime_error("change set index " + std::to_string(index) + " is out of schema bounds");
+        }
+        return this->decoders[index];
+    }
+};
+
+template<typename Archive, bool OnlyNew = true>
+void serialize_commit_changes(Archive &archive, const commit_t &commit, const schema_encoder_t &encoder) {
+    if (commit.change_sets.size() > UINT16_MAX) {
+        throw std::runtime_error("commit contains more than " + std::to_string(UINT16_MAX) + " change sets");
+    }
+    uint16_t change_sets = commit.change_sets.size();
+    archive(change_sets);
+    for (const auto &change_set : commit.change_sets) {
+        archive(encoder.index(change_set->id));
+        serialize_change_set<Archive, OnlyNew>(archive, *change_set);
+    }
+}
+
+template<typename Archive, bool OnlyNew = true>
+void serialize_commit(Archive &archive, const commit_t &commit, const schema_encoder_t &encoder) {
+    serialize_commit_entity_versions(archive, commit);
+    serialize_entity_list(archive, commit.created_entities);
+    serialize_commit_changes<Archive, OnlyNew>(archive, commit, encoder);
+    serialize_entity_list(archive, commit.destroyed_entities);
+}
+
+template<typename Archive>
+std::vector<std::unique_ptr<ecs_history::base_change_set_t> > deserialize_commit_changes(
+    Archive &archive, const schema_decoder_t<Archive> &decoder) {
+    std::vector<std::unique_ptr<ecs_history::base_change_set_t> > change_sets;
+    uint16_t change_set_count;
+    archive(change_set_count);
+    change_sets.reserve(change_set_count);
+    for (uint16_t i = 0; i < change_set_count; ++i) {
+        uint16_t index;
+        archive(index);
+        change_sets.push_back(decoder.decoder(index)(archive));
+    }
+    return change_sets;
+}
+
+template<typename Archive>
+std::unique_ptr<commit_t> deserialize_commit(Archive &archive, const schema_decoder_t<Archive> &decoder) {
+    return deserialize_commit_with(archive, [&decoder](Archive &changes_archive) {
+        return serialization::deserialize_commit_changes(changes_archive, decoder);
+    });
+}
+}
+
+#endif //ECS_NET_SCHEMA_HPP
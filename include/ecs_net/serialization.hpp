@@ -10,6 +10,7 @@
 #include "component_serialization.hpp"
 #include "change_serialization.hpp"
 #include <entt/entt.hpp>
+#include <string>
 
 #include "commit.hpp"
 #include "entity_version.hpp"
@@ -36,6 +37,9 @@ template<typename Archive, traits_t traits = traits_t::NO>
 void serialize_registry(Archive &archive, entt::registry &reg) {
     const auto &static_entities = reg.ctx().get<ecs_history::static_entities_t>();
     auto &version_handler = reg.ctx().get<entity_version_handler_t>();
+    // Sent back by reconnecting clients to receive only what changed since this snapshot
+    archive(version_handler.get_epoch());
+    archive(version_handler.get_generation());
 
     if constexpr (traits != traits_t::NO) {
         const uint16_t numSets = std::ranges::count_if(reg.storage(),
@@ -62,7 +66,7 @@ void serialize_registry(Archive &archive, entt::registry &reg) {
                 continue;
             }
         }
-        serialize_storage(archive, storage, static_entities, version_handler);
+        serialize_storage(archive, storage, static_entities);
     }
 
     const uint32_t entities = reg.storage<entt::entity>().size();
@@ -76,31 +80,137 @@ void serialize_registry(Archive &archive, entt::registry &reg) {
 }
 
 template<typename Archive>
-void serialize_commit(Archive &archive, commit_t &commit) {
+void serialize_commit_entity_versions(Archive &archive, const commit_t &commit) {
     uint32_t entity_version_count = commit.entity_versions.size();
     archive(entity_version_count);
     for (const auto &[static_entity, version] : commit.entity_versions) {
         archive(static_entity);
         archive(version);
     }
-    uint32_t created_entity_count = commit.created_entities.size();
-    archive(created_entity_count);
-    for (const ecs_history::static_entity_t &created_entity : commit.created_entities) {
-        archive(created_entity);
+}
+
+template<typename Archive>
+void serialize_entity_list(Archive &archive, const std::vector<ecs_history::static_entity_t> &static_entities) {
+    uint32_t entity_count = static_entities.size();
+    archive(entity_count);
+    for (const ecs_history::static_entity_t &static_entity : static_entities) {
+        archive(static_entity);
+    }
+}
+
+template<typename Archive, bool OnlyNew = true>
+void serialize_change_set(Archive &archive, ecs_history::base_change_set_t &change_set) {
+    change_serializer<Archive, OnlyNew> serializer{archive};
+    uint32_t count = change_set.count();
+    archive(count);
+    change_set.supply(serializer);
+}
+
+template<typename Archive, bool OnlyNew = true>
+void serialize_commit_changes(Archive &archive, const commit_t &commit) {
+    if (commit.change_sets.size() > UINT16_MAX) {
+        throw std::runtime_error("commit contains more than " + std::to_string(UINT16_MAX) + " change sets");
     }
     uint16_t change_sets = commit.change_sets.size();
     archive(change_sets);
-    change_serializer<Archive> serializer{archive};
     for (const auto &change_set : commit.change_sets) {
         archive(change_set->id);
-        uint32_t count = change_set->count();
-        archive(count);
-        change_set->supply(serializer);
+        serialize_change_set<Archive, OnlyNew>(archive, *change_set);
+    }
+}
+
+template<typename Archive, bool OnlyNew = true>
+void serialize_commit(Archive &archive, const commit_t &commit) {
+    serialize_commit_entity_versions(archive, commit);
+    serialize_entity_list(archive, commit.created_entities);
+    serialize_commit_changes<Archive, OnlyNew>(archive, commit);
+    serialize_entity_list(archive, commit.destroyed_entities);
+}
+
+template<typename Archive>
+void serialize_storage_since(Archive &archive,
+                             const entt::basic_sparse_set<> &storage,
+                             const std::vector<std::pair<ecs_history::static_entity_t, entt::entity> > &changed_entities) {
+    const auto meta = entt::resolve(storage.info().hash());
+    std::vector<std::pair<ecs_history::static_entity_t, entt::entity> > contained;
+    for (const auto &changed_entity : changed_entities) {
+        if (storage.contains(changed_entity.second)) {
+            contained.push_back(changed_entity);
+        }
     }
-    uint32_t deleted_entity_count = commit.destroyed_entities.size();
-    archive(deleted_entity_count);
-    for (const ecs_history::static_entity_t &deleted_entity : commit.destroyed_entities) {
-        archive(deleted_entity);
+    archive(static_cast<uint64_t>(storage.info().hash()));
+    archive(static_cast<uint32_t>(contained.size()));
+    for (const auto &[static_entity, entt] : contained) {
+        archive(static_entity);
+        const void *value = storage.value(entt);
+        const entt::meta_any any = meta.from_void(value);
+        serialize_component<Archive, true>(archive, any);
+    }
+}
+
+/**
+ * Serializes everything that changed since a generation, e.g. the one of a client's last snapshot.
+ * Changed entities are sent with their version, followed by the changed entities that were destroyed.
+ * Only storages changed since the generation are sent, each with the components of changed entities.
+ * A changed entity missing in a sent storage no longer has that component.
+ * Throws if the changes cannot be computed (see entity_version_handler_t::can_serialize_since),
+ * the receiver needs a full serialize_registry then.
+ * @param archive The archive
+ * @param reg The registry
+ * @param epoch The epoch of the receiver's last snapshot
+ * @param since The generation the receiver is up to date with
+ */
+template<typename Archive, traits_t traits = traits_t::NO>
+void serialize_registry_since(Archive &archive, entt::registry &reg, const uint64_t epoch, const generation_t since) {
+    const auto &static_entities = reg.ctx().get<ecs_history::static_entities_t>();
+    auto &version_handler = reg.ctx().get<entity_version_handler_t>();
+    if (!version_handler.can_serialize_since(epoch, since)) {
+        throw std::runtime_error("changes since generation " + std::to_string(since) + " are not available");
+    }
+    archive(version_handler.get_epoch());
+    archive(version_handler.get_generation());
+
+    std::vector<std::pair<ecs_history::static_entity_t, entt::entity> > alive_entities;
+    std::vector<ecs_history::static_entity_t> destroyed_entities;
+    for (const ecs_history::static_entity_t &static_entity : version_handler.changed_entities(since)) {
+        if (version_handler.is_destroyed(static_entity)) {
+            destroyed_entities.push_back(static_entity);
+            continue;
+        }
+        const entt::entity entt = static_entities.get_entity(static_entity);
+        if (!reg.valid(entt)) {
+            destroyed_entities.push_back(static_entity);
+            continue;
+        }
+        alive_entities.emplace_back(static_entity, entt);
+    }
+    archive(static_cast<uint32_t>(alive_entities.size()));
+    for (const auto &[static_entity, entt] : alive_entities) {
+        const entity_version_t version = version_handler.get_version(static_entity);
+        archive(static_entity);
+        archive(version);
+    }
+    serialize_entity_list(archive, destroyed_entities);
+
+    std::vector<const entt::basic_sparse_set<> *> changed_storages;
+    for (auto [id, storage] : reg.storage()) {
+        const auto meta = entt::resolve(id);
+        if (!meta || version_handler.get_storage_generation(id) <= since) {
+            continue;
+        }
+        if constexpr (traits != traits_t::NO) {
+            if (!(meta.traits<traits_t>() & traits)) {
+                continue;
+            }
+        }
+        changed_storages.push_back(&storage);
+    }
+    if (changed_storages.size() > UINT16_MAX) {
+        throw std::runtime_error("registry contains more than " + std::to_string(UINT16_MAX) + " changed storages");
+    }
+    archive(static_cast<uint16_t>(changed_storages.size()));
+    for (const auto *storage : changed_storages) {
+        serialize_storage_since(archive, *storage, alive_entities);
     }
 }
 
@@ -171,11 +281,16 @@ std::vector<std::unique_ptr<ecs_history::base_change_set_t> > deserialize_commit
     return change_sets;
 }
 
-template<typename Archive>
-std::unique_ptr<commit_t> deserialize_commit(Archive &archive) {
+/**
+ * Deserializes a commit, shared by all wire formats which only differ in how change sets are encoded
+ * @param archive The archive
+ * @param deserialize_changes Deserializes the change sets of the commit from the archive
+ */
+template<typename Archive, typename DeserializeChanges>
+std::unique_ptr<commit_t> deserialize_commit_with(Archive &archive, DeserializeChanges &&deserialize_changes) {
     auto entity_versions = serialization::deserialize_commit_entity_versions(archive);
     auto created_entities = serialization::deserialize_entity_list(archive);
-    auto changes = serialization::deserialize_commit_changes(archive);
+    auto changes = deserialize_changes(archive);
     auto removed_entities = serialization::deserialize_entity_list(archive);
     return std::make_unique<commit_t>(
         std::move(entity_versions),
@@ -183,6 +298,13 @@ std::unique_ptr<commit_t> deserialize_commit(Archive &archive) {
         std::move(changes),
         std::move(removed_entities));
 }
+
+template<typename Archive>
+std::unique_ptr<commit_t> deserialize_commit(Archive &archive) {
+    return deserialize_commit_with(archive, [](Archive &changes_archive) {
+        return serialization::deserialize_commit_changes(changes_archive);
+    });
+}
 }
 
 #endif //ECS_NET_SERIALIZATION_H
\ No newline at end of file
@@ -0,0 +1,169 @@
+//
+// Created by felix on 1/18/26.
+//
+
+#ifndef ECS_NET_SNAPSHOT_HPP
+#define ECS_NET_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "serialization.hpp"
+
+namespace ecs_net::serialization {
+struct storage_snapshot_t {
+    entt::id_type id;
+    entt::meta_type type;
+    std::vector<ecs_history::static_entity_t> entities;
+    // Raw copies of TRIVIAL components, type.size_of() bytes per entity
+    std::vector<std::byte> bytes;
+    // Owning copies of all other components, independent of the registry they were captured from
+    std::vector<entt::meta_any> values;
+};
+
+struct registry_snapshot_t {
+    uint64_t epoch = 0;
+    generation_t generation = 0;
+    std::vector<storage_snapshot_t> storages;
+    std::vector<std::pair<ecs_history::static_entity_t, entity_version_t> > entities;
+};
+
+/**
+ * Copies all serializable storages of the registry. This is the only step that has to run
+ * on the simulation thread, encoding the snapshot can happen concurrently afterward.
+ * TRIVIAL components are copied as raw bytes into one buffer per storage. All other components
+ * are deep copied one by one, which still costs time proportional to their count on this thread.
+ * @tparam traits Only capture storages of components with these traits
+ * @param reg The registry
+ * @return The snapshot
+ */
+template<traits_t traits = traits_t::NO>
+registry_snapshot_t capture_registry(entt::registry &reg) {
+    const auto &static_entities = reg.ctx().get<ecs_history::static_entities_t>();
+    auto &version_handler = reg.ctx().get<entity_version_handler_t>();
+
+    registry_snapshot_t snapshot;
+    snapshot.epoch = version_handler.get_epoch();
+    snapshot.generation = version_handler.get_generation();
+    for (auto [id, storage] : reg.storage()) {
+        const auto meta = entt::resolve(id);
+        if (!meta) {
+            continue;
+        }
+        if constexpr (traits != traits_t::NO) {
+            if (!(meta.traits<traits_t>() & traits)) {
+                continue;
+            }
+        }
+        storage_snapshot_t &storage_snapshot = snapshot.storages.emplace_back();
+        storage_snapshot.id = storage.info().hash();
+        storage_snapshot.type = meta;
+        storage_snapshot.entities.reserve(storage.size());
+        for (const auto &entt : storage) {
+            storage_snapshot.entities.push_back(static_entities.get_static_entity(entt));
+        }
+
+        const size_t size = meta.size_of();
+        if (!!(meta.traits<traits_t>() & traits_t::TRIVIAL) && size > 0) {
+            storage_snapshot.bytes.resize(storage.size() * size);
+            std::byte *data = storage_snapshot.bytes.data();
+            for (const auto &entt : storage) {
+                std::memcpy(data, storage.value(entt), size);
+                data += size;
+            }
+            continue;
+        }
+        storage_snapshot.values.reserve(storage.size());
+        for (const auto &entt : storage) {
+            const entt::meta_any value = meta.from_void(storage.value(entt));
+            // Copying a meta_any that references an element copies the element itself
+            storage_snapshot.values.push_back(value);
+            if (!storage_snapshot.values.back()) {
+                const auto type_name = std::string{meta.info().name()};
+                throw std::runtime_error("could not copy component of type " + type_name + " into snapshot");
+            }
+        }
+    }
+
+    snapshot.entities.reserve(reg.storage<entt::entity>().size());
+    for (const auto &entt : reg.storage<entt::entity>()) {
+        const ecs_history::static_entity_t static_entity = static_entities.get_static_entity(entt);
+        snapshot.entities.emplace_back(static_entity, version_handler.get_version(static_entity));
+    }
+    return snapshot;
+}
+
+template<typename Archive>
+void serialize_storage_snapshot(Archive &archive, const storage_snapshot_t &storage) {
+    archive(static_cast<uint64_t>(storage.id));
+    archive(static_cast<uint32_t>(storage.entities.size()));
+    const size_t size = storage.type.size_of();
+    for (size_t i = 0; i < storage.entities.size(); ++i) {
+        archive(storage.entities[i]);
+        if (storage.values.empty()) {
+            const entt::meta_any value = storage.type.from_void(storage.bytes.data() + i * size);
+            serialize_component<Archive, true>(archive, value.as_ref());
+        } else {
+            serialize_component<Archive, true>(archive, storage.values[i].as_ref());
+        }
+    }
+}
+
+/**
+ * Serializes a captured snapshot, encoding storages on up to workers threads.
+ * Every storage is written as a separately encoded byte string (same layout as serialize_storage),
+ * so the output does not depend on the number of workers and storages can be decoded independently.
+ * @tparam Archive The type of Archive to write to, must be constructible from a std::ostream
+ * @param archive The archive
+ * @param snapshot The snapshot
+ * @param workers The number of threads encoding storages
+ */
+template<typename Archive>
+void serialize_snapshot(Archive &archive, const registry_snapshot_t &snapshot, size_t workers = 1) {
+    workers = std::clamp<size_t>(workers, 1, std::max<size_t>(snapshot.storages.size(), 1));
+
+    std::vector<std::string> encoded_storages(snapshot.storages.size());
+    std::vector<std::future<void> > futures;
+    futures.reserve(workers);
+    for (size_t worker = 0; worker < workers; ++worker) {
+        futures.push_back(std::async(std::launch::async, [&, worker] {
+            for (size_t i = worker; i < snapshot.storages.size(); i += workers) {
+                std::ostringstream stream;
+                {
+                    Archive storage_archive{stream};
+                    serialize_storage_snapshot(storage_archive, snapshot.storages[i]);
+                }
+                encoded_storages[i] = std::move(stream).str();
+            }
+        }));
+    }
+    for (auto &future : futures) {
+        // Rethrows exceptions of the workers
+        future.get();
+    }
+
+    archive(snapshot.epoch);
+    archive(snapshot.generation);
+    if (encoded_storages.size() > UINT16_MAX) {
+        throw std::runtime_error("snapshot contains more than " + std::to_string(UINT16_MAX) + " storages");
+    }
+    archive(static_cast<uint16_t>(encoded_storages.size()));
+    for (const std::string &encoded_storage : encoded_storages) {
+        archive(encoded_storage);
+    }
+    archive(static_cast<uint32_t>(snapshot.entities.size()));
+    for (const auto &[static_entity, version] : snapshot.entities) {
+        archive(static_entity);
+        archive(version);
+    }
+}
+}
+
+#endif //ECS_NET_SNAPSHOT_HPP
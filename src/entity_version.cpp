@@ -4,6 +4,9 @@
 
 #include "ecs_net/entity_version.hpp"
 
+#include <algorithm>
+#include <random>
+
 ecs_net::entity_version_t ecs_net::entity_version_handler_t::get_version(const ecs_history::static_entity_t entity) {
     return this->versions[entity];
 }
@@ -30,3 +33,83 @@ void ecs_net::entity_version_handler_t::
 add_entity(const ecs_history::static_entity_t entity, const entity_version_t version) {
     this->versions[entity] = version;
 }
+
+ecs_net::entity_version_handler_t::entity_version_handler_t() {
+    std::random_device rd;
+    std::mt19937_64 gen{rd()};
+    this->epoch = gen();
+}
+
+uint64_t ecs_net::entity_version_handler_t::get_epoch() const {
+    return this->epoch;
+}
+
+ecs_net::generation_t ecs_net::entity_version_handler_t::get_generation() const {
+    return this->generation;
+}
+
+ecs_net::generation_t ecs_net::entity_version_handler_t::get_horizon() const {
+    return this->horizon;
+}
+
+void ecs_net::entity_version_handler_t::set_retained_generations(const generation_t generations) {
+    this->retained_generations = generations;
+    this->prune();
+}
+
+ecs_net::generation_t ecs_net::entity_version_handler_t::next_generation() {
+    ++this->generation;
+    this->prune();
+    return this->generation;
+}
+
+void ecs_net::entity_version_handler_t::prune() {
+    if (this->generation <= this->retained_generations) {
+        return;
+    }
+    this->horizon = std::max(this->horizon, this->generation - this->retained_generations);
+    while (!this->entity_log.empty() && this->entity_log.front().first <= this->horizon) {
+        const auto [entity_generation, entity] = this->entity_log.front();
+        this->entity_log.pop_front();
+        const auto it = this->entity_generations.find(entity);
+        // Entities marked again later on are still in the log with their newer generation
+        if (it != this->entity_generations.end() && it->second.generation == entity_generation) {
+            this->entity_generations.erase(it);
+        }
+    }
+}
+
+void ecs_net::entity_version_handler_t::mark_entity(const ecs_history::static_entity_t entity, const bool destroyed) {
+    this->entity_generations[entity] = entity_generation_t{this->generation, destroyed};
+    this->entity_log.emplace_back(this->generation, entity);
+}
+
+void ecs_net::entity_version_handler_t::mark_storage(const entt::id_type storage) {
+    this->storage_generations[storage] = this->generation;
+}
+
+bool ecs_net::entity_version_handler_t::is_destroyed(const ecs_history::static_entity_t entity) const {
+    const auto it = this->entity_generations.find(entity);
+    return it != this->entity_generations.end() && it->second.destroyed;
+}
+
+ecs_net::generation_t ecs_net::entity_version_handler_t::get_storage_generation(const entt::id_type storage) const {
+    const auto it = this->storage_generations.find(storage);
+    return it == this->storage_generations.end() ? 0 : it->second;
+}
+
+bool ecs_net::entity_version_handler_t::can_serialize_since(const uint64_t epoch, const generation_t since) const {
+    return epoch == this->epoch && since >= this->horizon && since <= this->generation;
+}
+
+std::vector<ecs_history::static_entity_t> ecs_net::entity_version_handler_t::changed_entities(
+    const generation_t since) const {
+    std::vector<ecs_history::static_entity_t> entities;
+    for (auto it = this->entity_log.rbegin(); it != this->entity_log.rend() && it->first > since; ++it) {
+        // Only the latest mark of an entity matches its generation, so every entity is added once
+        if (this->entity_generations.at(it->second).generation == it->first) {
+            entities.push_back(it->second);
+        }
+    }
+    return entities;
+}